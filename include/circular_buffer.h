@@ -1,5 +1,6 @@
 #pragma once
 
+#include <chrono>
 #include <cstring>
 #include <mutex>
 #include <vector>
@@ -19,6 +20,8 @@ class CircularBuffer {
     using LockGuard = std::lock_guard<Mutex>;
 
 public:
+    using Clock = std::chrono::steady_clock;
+
     class DataBlock {
     public:
         // Get the current readHead
@@ -32,8 +35,8 @@ public:
         }
 
         // Move readhead forward n bytes or till the end of capacity
-        void MarkFilled(size_t bytes) {
-            m_parent->MarkAsWritten(bytes);
+        void MarkFilled(size_t bytes, Clock::time_point receivedAt = Clock::now()) {
+            m_parent->MarkAsWritten(bytes, receivedAt);
         }
 
     private:
@@ -52,6 +55,7 @@ public:
 public:
     CircularBuffer() {
         m_data.resize(N);
+        m_writeMarks.resize(kMaxWriteMarks);
         m_writeHead = m_readHead = 0;
         // std::cout << "Created Queue of size " << N << " bytes of data" << std::endl;
     }
@@ -61,7 +65,10 @@ public:
         return DataBlock(this, reinterpret_cast<T *>(m_data.data()) + m_writeHead, freeSpace());
     }
 
-    std::string GetLine() {
+    // Get the next full line. If receivedAt is given, it is set to the time
+    // the first byte of the line was written into the buffer, or left empty if unknown.
+    // If generation is given, it is set to the generation the line was written in
+    std::string GetLine(Clock::time_point *receivedAt = nullptr, uint32_t *generation = nullptr) {
         const LockGuard lock(m_mutex);
         char *stringBuffer = reinterpret_cast<char *>(m_data.data());
         auto bufferEnd = m_readHead > m_writeHead ? MAX_SIZE : m_writeHead;
@@ -71,7 +78,8 @@ public:
             std::string str;
             stringStart = -1;
             for (searchIndex = start; searchIndex < end; searchIndex++) {
-                if (stringBuffer[searchIndex] == '\r' || stringBuffer[searchIndex] == '\n') {
+                // Consumed delimiters are zeroed but the readHead may still point at them
+                if (stringBuffer[searchIndex] == '\r' || stringBuffer[searchIndex] == '\n' || stringBuffer[searchIndex] == 0) {
                     stringBuffer[searchIndex] = 0;
                     if (stringStart < 0) {
                         // We havent found a string yet, continue
@@ -92,11 +100,12 @@ public:
         std::string line = findFullString(m_readHead, bufferEnd);
         if (stringStart >= 0 && searchIndex < bufferEnd) {
             // We found a proper line
-            m_readHead = (searchIndex + 1) % MAX_SIZE;
+            MarkAsRead(stringStart, (searchIndex + 1) % MAX_SIZE, receivedAt, generation);
             return line;
         }
         // Need to do rollover
         if (searchIndex == MAX_SIZE && stringStart >= 0) {
+            const size_t lineStart = stringStart;
             // We found a start, but needs to wrap around
             // std::cout << "Buffer rollover: " << m_readHead << std::endl;
             std::string tempString = std::string(&stringBuffer[stringStart], searchIndex - stringStart);
@@ -107,7 +116,7 @@ public:
             auto newString = findFullString(0, m_writeHead);
             if (stringStart >= 0 && searchIndex < m_writeHead) {
                 // We found a proper line again
-                m_readHead = (searchIndex + 1) % MAX_SIZE;
+                MarkAsRead(lineStart, (searchIndex + 1) % MAX_SIZE, receivedAt, generation);
                 tempString.append(newString);
                 line = tempString;
             }
@@ -116,6 +125,14 @@ public:
         return line;
     }
 
+    // Start a new generation after the data source was interrupted, eg: device reconnected.
+    // The unterminated line at the end of the buffer is dropped, complete lines are kept
+    void StartNewGeneration() {
+        const LockGuard lock(m_mutex);
+        DropPartialLine();
+        m_generation++;
+    }
+
     size_t freeSpace() {
         const LockGuard lock(m_mutex);
 
@@ -138,16 +155,90 @@ public:
     }
 
 private:
+    // Arrival time of every write that still has unread data
+    struct WriteMark {
+        uint64_t end;  // Total bytes written including this write
+        Clock::time_point receivedAt;
+        uint32_t generation;
+    };
+    // Every pending mark covers at least one unread byte, so the table can never overflow
+    static constexpr size_t kMaxWriteMarks = N;
+
     std::vector<T> m_data;
     Mutex m_mutex;
     size_t m_writeHead = 0;  // HEAD
     size_t m_readHead = 0;  // TAIL
+    uint64_t m_totalWritten = 0;
+    uint64_t m_totalRead = 0;
+    uint32_t m_generation = 0;
+    std::vector<WriteMark> m_writeMarks;
+    size_t m_firstMark = 0;
+    size_t m_numMarks = 0;
     static constexpr size_t MAX_SIZE = N;
 
-    void MarkAsWritten(size_t numBytes) {
+    void MarkAsWritten(size_t numBytes, Clock::time_point receivedAt) {
         const LockGuard lock(m_mutex);
         auto size = std::min(MAX_SIZE - m_writeHead, numBytes);
         m_writeHead = (m_writeHead + size) % MAX_SIZE;
+        if (size == 0) {
+            return;
+        }
+        m_totalWritten += size;
+        m_writeMarks[(m_firstMark + m_numMarks) % kMaxWriteMarks] = {m_totalWritten, receivedAt, m_generation};
+        m_numMarks++;
+    }
+
+    // Move the readHead to newReadHead and drop the write marks that are fully read
+    void MarkAsRead(size_t lineStart, size_t newReadHead, Clock::time_point *receivedAt, uint32_t *generation) {
+        const uint64_t lineOffset = m_totalRead + (lineStart + MAX_SIZE - m_readHead) % MAX_SIZE;
+        m_totalRead += (newReadHead + MAX_SIZE - m_readHead) % MAX_SIZE;
+        m_readHead = newReadHead;
+
+        while (m_numMarks > 0 && m_writeMarks[m_firstMark].end <= lineOffset) {
+            PopWriteMark();
+        }
+        if (receivedAt) {
+            *receivedAt = m_numMarks > 0 ? m_writeMarks[m_firstMark].receivedAt : Clock::time_point {};
+        }
+        if (generation) {
+            *generation = m_numMarks > 0 ? m_writeMarks[m_firstMark].generation : m_generation;
+        }
+        while (m_numMarks > 0 && m_writeMarks[m_firstMark].end <= m_totalRead) {
+            PopWriteMark();
+        }
+    }
+
+    // Move the writeHead back to just after the last delimiter of the unread data
+    void DropPartialLine() {
+        const uint64_t unread = m_totalWritten - m_totalRead;
+        size_t dropped = 0;
+        while (dropped < unread) {
+            auto &byte = m_data[(m_writeHead + MAX_SIZE - 1 - dropped) % MAX_SIZE];
+            if (byte == '\r' || byte == '\n' || byte == 0) {
+                break;
+            }
+            byte = 0;
+            dropped++;
+        }
+        m_writeHead = (m_writeHead + MAX_SIZE - dropped) % MAX_SIZE;
+        m_totalWritten -= dropped;
+
+        // Trim the write marks to the remaining data
+        while (m_numMarks > 1 && m_writeMarks[(m_firstMark + m_numMarks - 2) % kMaxWriteMarks].end >= m_totalWritten) {
+            m_numMarks--;
+        }
+        if (m_numMarks > 0) {
+            auto &last = m_writeMarks[(m_firstMark + m_numMarks - 1) % kMaxWriteMarks];
+            last.end = std::min(last.end, m_totalWritten);
+        }
+        while (m_numMarks > 0 && m_writeMarks[m_firstMark].end <= m_totalRead) {
+            PopWriteMark();
+        }
+    }
+
+    void PopWriteMark() {
+        m_firstMark = (m_firstMark + 1) % kMaxWriteMarks;
+        m_numMarks--;
     }
 
     friend class DataBlock;
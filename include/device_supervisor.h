@@ -0,0 +1,73 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <latency_tracer.h>
+#include <serial_device.h>
+#include <string>
+
+namespace PacificScales {
+
+/**
+ * @brief Keeps a SerialDevice open across hot-plug events.
+ * Watches the directory of the device node (eg: /dev or /dev/serial/by-id) with inotify
+ * and reopens the device as soon as the node reappears.
+ *
+ * Open/Read must only be done from one thread, the statistics can be read from any thread.
+ */
+class DeviceSupervisor {
+public:
+    DeviceSupervisor(std::string device, BaudRate baudRate);
+    ~DeviceSupervisor();
+    DeviceSupervisor(const DeviceSupervisor &) = delete;
+    DeviceSupervisor &operator=(const DeviceSupervisor &) = delete;
+
+    bool EnsureOpen(std::chrono::milliseconds timeout);
+    bool DeviceRemoved();
+    void MarkLost(bool nodeRemoved = false);
+    void MarkDataReceived();
+    SerialDevice &Device() { return m_serialDevice; }
+
+    bool isConnected() const { return m_connected.load(std::memory_order_relaxed); }
+    bool wasOpened() const { return m_wasOpened.load(std::memory_order_relaxed); }
+    uint32_t Reconnects() const { return m_reconnects.load(std::memory_order_relaxed); }
+    TraceClock::duration Downtime() const;
+    std::string Report() const;
+
+private:
+    // Events seen for our device node
+    enum DeviceEvent
+    {
+        NONE = 0,
+        APPEARED = 1,
+        REMOVED = 2,
+    };
+
+    static constexpr auto kPollInterval = std::chrono::milliseconds(50);
+    static constexpr auto kMaxBackoff = std::chrono::milliseconds(2000);
+
+    bool TryOpen();
+    bool AddWatch();
+    int ReadEvents();
+    bool WaitForDevice(std::chrono::milliseconds timeout);
+
+    std::string m_device;
+    std::string m_watchDir;
+    std::string m_deviceName;
+    BaudRate m_baudRate;
+    SerialDevice m_serialDevice;
+    int m_inotifyFd = -1;
+    int m_watch = -1;
+    bool m_waitingLogged = false;  // "Waiting for" was printed for the current outage
+    bool m_awaitingData = false;  // Reopened, but the reconnect is not confirmed until data arrives
+    std::chrono::milliseconds m_backoff = kPollInterval;  // Delay before reopening a device that failed while its node stayed
+    TraceClock::time_point m_reopenNotBefore = {};
+
+    std::atomic<bool> m_wasOpened = {false};
+    std::atomic<bool> m_connected = {false};
+    std::atomic<uint32_t> m_reconnects = {0};
+    std::atomic<int64_t> m_downtimeNs = {0};  // Total of all the finished outages
+    std::atomic<int64_t> m_downSinceNs = {0};  // Start of the current outage, only after the first open
+};
+
+}  // namespace
@@ -0,0 +1,69 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <string>
+
+namespace PacificScales {
+
+// Monotonic clock used for all per-frame timestamps
+using TraceClock = std::chrono::steady_clock;
+
+/**
+ * @brief Timestamps collected for a single scale data frame as it moves
+ * through the reader -> buffer -> parser pipeline
+ */
+struct FrameTrace {
+    TraceClock::time_point received;  // First byte of the frame read from the device
+    TraceClock::time_point delimited;  // End-of-frame line extracted from the buffer
+    TraceClock::time_point published;  // Frame visible through ScaleDataParser::Latest()
+};
+
+/**
+ * @brief Lock-free HDR-style histogram of latencies in nanoseconds.
+ * Values are bucketed log-linearly (32 sub-buckets per power of two, ~3% precision).
+ * Record() can be called concurrently from any number of threads.
+ */
+class LatencyHistogram {
+public:
+    LatencyHistogram() = default;
+    LatencyHistogram(const LatencyHistogram &) = delete;
+    LatencyHistogram &operator=(const LatencyHistogram &) = delete;
+
+    void Record(TraceClock::duration latency);
+    uint64_t Count() const { return m_count.load(std::memory_order_relaxed); }
+    uint64_t Max() const { return m_max.load(std::memory_order_relaxed); }
+    uint64_t Percentile(double percentile) const;
+
+private:
+    static constexpr unsigned kSubBucketBits = 5;
+    static constexpr uint64_t kSubBuckets = 1ULL << kSubBucketBits;
+    static constexpr unsigned kMaxValueBits = 40;  // ~18 minutes in nanoseconds
+    static constexpr size_t kNumBuckets = (kMaxValueBits - kSubBucketBits + 1) * kSubBuckets;
+
+    static size_t BucketIndex(uint64_t value);
+    static uint64_t BucketUpperBound(size_t index);
+
+    std::array<std::atomic<uint64_t>, kNumBuckets> m_buckets = {};
+    std::atomic<uint64_t> m_count = {0};
+    std::atomic<uint64_t> m_max = {0};
+};
+
+/**
+ * @brief Records stage-to-stage latencies of parsed frames
+ *
+ */
+class LatencyTracer {
+public:
+    void Record(const FrameTrace &trace);
+    std::string Report() const;
+
+private:
+    LatencyHistogram m_receiveToDelimiter;
+    LatencyHistogram m_delimiterToPublished;
+    LatencyHistogram m_endToEnd;
+};
+
+}  // namespace
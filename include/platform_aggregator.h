@@ -0,0 +1,113 @@
+#pragma once
+
+#include <chrono>
+#include <deque>
+#include <latency_tracer.h>
+#include <memory>
+#include <mutex>
+#include <scale_data_parser.h>
+#include <spsc_queue.h>
+#include <string>
+#include <vector>
+
+namespace PacificScales {
+
+/**
+ * @brief Summary of one platform frame, small and trivially copyable so that
+ * handing it to the aggregator never allocates
+ */
+struct PlatformFrame {
+    int32_t total = 0;
+    bool valid = false;
+    TraceClock::time_point timestamp = {};  // First byte of the frame read from the device
+};
+
+/**
+ * @brief Combined reading of all the platforms of a weighbridge for one time slot
+ *
+ */
+class AggregatedData {
+public:
+    struct PlatformReading {
+        std::string name;
+        PlatformFrame frame;
+        bool present = false;  // A frame from this platform fell inside the slot
+    };
+
+    AggregatedData() = default;
+    explicit AggregatedData(TraceClock::time_point timestamp)
+        : m_timestamp(timestamp) { }
+
+    void AddPlatform(std::string name, const PlatformFrame &frame, bool present);
+    int64_t Gross() const;
+    bool isValid() const;
+    std::string toJson() const;
+    TraceClock::time_point Timestamp() const { return m_timestamp; }
+
+private:
+    TraceClock::time_point m_timestamp = {};
+    std::vector<PlatformReading> m_platforms;
+};
+
+/**
+ * @brief Aligns frames from several platforms on their monotonic timestamps
+ * and combines the ones that fall within the skew window into a single slot.
+ *
+ * Each platform has its own lock-free queue, so every device pipeline can submit
+ * without blocking the others. Process() must only be called from one thread.
+ */
+class PlatformAggregator {
+public:
+    PlatformAggregator(std::vector<std::string> platformNames, std::chrono::milliseconds skewWindow,
+                       std::chrono::milliseconds lateness);
+    PlatformAggregator(const PlatformAggregator &) = delete;
+    PlatformAggregator &operator=(const PlatformAggregator &) = delete;
+
+    FrameListener *Input(size_t platform);
+    bool Submit(size_t platform, const PlatformFrame &frame);
+    void Process(TraceClock::time_point now);
+    const AggregatedData Latest() {
+        const std::lock_guard<std::mutex> lock(m_mutex);
+        return m_latest;
+    };
+
+private:
+    // Feeds the frames of one parser into its platform queue
+    class PlatformInput : public FrameListener {
+    public:
+        PlatformInput(PlatformAggregator *aggregator, size_t platform)
+            : m_aggregator(aggregator)
+            , m_platform(platform) { }
+        void OnFrame(const ScaleData &data) override;
+
+    private:
+        PlatformAggregator *m_aggregator;
+        size_t m_platform;
+    };
+
+    struct PendingFrame {
+        PlatformFrame frame;
+        TraceClock::time_point arrival;  // When Process() picked it up
+    };
+
+    static constexpr size_t kQueueSize = 64;
+    using FrameQueue = SpscQueue<PlatformFrame, kQueueSize>;
+
+    void DropStaleFrames();
+    void UpdateLatest(const AggregatedData latest);
+
+    std::vector<std::string> m_platformNames;
+    TraceClock::duration m_skewWindow;
+    TraceClock::duration m_lateness;
+    std::vector<std::unique_ptr<FrameQueue>> m_queues;
+    std::vector<std::unique_ptr<PlatformInput>> m_inputs;
+
+    // Only touched by Process()
+    std::vector<std::deque<PendingFrame>> m_pending;
+    TraceClock::time_point m_lastWindowEnd = {};
+
+    std::mutex m_mutex;
+    AggregatedData m_latest = {};
+};
+
+}  // namespace
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <cstring>
+#include <latency_tracer.h>
 #include <map>
 #include <mutex>
 #include <string>
@@ -10,11 +11,27 @@ namespace PacificScales {
 class ScaleData {
 public:
     void AddDataChannel(std::string channel, int32_t mass);
-    bool isValid();
+    bool isValid() const;
+    int32_t Total() const;
     std::string toJson() const;
 
+    // Monotonic time the frame was received from the device
+    TraceClock::time_point Timestamp() const { return m_timestamp; }
+    void SetTimestamp(TraceClock::time_point timestamp) { m_timestamp = timestamp; }
+
 private:
     std::map<std::string, int32_t> m_channelMassMap;
+    TraceClock::time_point m_timestamp = {};
+};
+
+/**
+ * @brief Receives every frame published by a ScaleDataParser, called from the parsing thread
+ *
+ */
+class FrameListener {
+public:
+    virtual ~FrameListener() = default;
+    virtual void OnFrame(const ScaleData &data) = 0;
 };
 
 /**
@@ -28,10 +45,14 @@ class ScaleDataParser {
         STARTED,  // We got '/' as input
         TOTAL_PARSED,  // All the channels are parsed, waiting for '\\'
         FINISHED,  // All done with this block
+        RESYNC,  // Reset in the middle of a block, ignore everything till the next '/'
     };
 
 public:
-    void ParseLine(std::string line);
+    void ParseLine(std::string line, TraceClock::time_point received = {}, TraceClock::time_point delimited = {});
+    void SetLatencyTracer(LatencyTracer *tracer) { m_tracer = tracer; }
+    void SetFrameListener(FrameListener *listener) { m_frameListener = listener; }
+    void Reset();
     const ScaleData Latest() {
         const std::lock_guard<std::mutex> lock(m_mutex);
         return m_latest;
@@ -43,6 +64,9 @@ private:
     ScaleData m_latest = {};
     ScaleData m_current = {};
     ParserState m_parserState = ParserState::UNKNOWN;
+    LatencyTracer *m_tracer = nullptr;
+    FrameListener *m_frameListener = nullptr;
+    FrameTrace m_trace = {};
 };
 
 }  //namespace
@@ -29,14 +29,18 @@ public:
     SerialDevice() = default;
     ~SerialDevice();
 
+    static bool isSupportedBaudRate(BaudRate baudRate);
     bool Open(const std::string device, BaudRate baudRate);
     bool isDeviceOpen() { return m_fd >= 0; };
     void Close();
-    int Read(void *dataBuffer, unsigned int bufferSize, std::chrono::milliseconds timeout);
+    int Read(void *dataBuffer, unsigned int bufferSize, std::chrono::milliseconds timeout,
+             std::chrono::steady_clock::time_point *firstByteAt = nullptr);
     void Flush();
     bool WaitForData(std::chrono::milliseconds timeout);
 
 private:
+    void CloseKeepingErrno();
+
     int m_fd = -1;
 };
 
@@ -0,0 +1,51 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <utility>
+
+namespace PacificScales {
+
+/**
+ * @brief Lock-free bounded queue for exactly one producer thread and one consumer thread.
+ * Holds up to N - 1 items.
+ */
+template <typename T, size_t N>
+class SpscQueue {
+public:
+    SpscQueue() = default;
+    SpscQueue(const SpscQueue &) = delete;
+    SpscQueue &operator=(const SpscQueue &) = delete;
+
+    // Producer side, returns false if the queue is full
+    bool Push(const T &item) {
+        const size_t tail = m_tail.load(std::memory_order_relaxed);
+        const size_t next = (tail + 1) % N;
+        if (next == m_head.load(std::memory_order_acquire)) {
+            return false;
+        }
+        m_items[tail] = item;
+        m_tail.store(next, std::memory_order_release);
+        return true;
+    }
+
+    // Consumer side, returns false if the queue is empty
+    bool Pop(T &item) {
+        const size_t head = m_head.load(std::memory_order_relaxed);
+        if (head == m_tail.load(std::memory_order_acquire)) {
+            return false;
+        }
+        item = std::move(m_items[head]);
+        m_head.store((head + 1) % N, std::memory_order_release);
+        return true;
+    }
+
+private:
+    std::array<T, N> m_items = {};
+    // Keep the indices on separate cache lines so producer and consumer don't contend
+    alignas(64) std::atomic<size_t> m_head = {0};
+    alignas(64) std::atomic<size_t> m_tail = {0};
+};
+
+}  // namespace
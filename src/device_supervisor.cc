@@ -0,0 +1,299 @@
+#include <device_supervisor.h>
+
+#include <errno.h>
+#include <poll.h>
+#include <sys/inotify.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+#include <string.h>
+#include <thread>
+
+namespace PacificScales {
+
+static int64_t toNanos(TraceClock::time_point timePoint) {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(timePoint.time_since_epoch()).count();
+}
+
+/**
+ * @brief Construct a new Device Supervisor. The device is not opened until EnsureOpen()
+ *
+ * @param device Full path of the serial device, eg: '/dev/ttyUSB0' or a /dev/serial/by-id link
+ * @param baudRate One of the supported baud rates
+ */
+DeviceSupervisor::DeviceSupervisor(std::string device, BaudRate baudRate)
+    : m_device(std::move(device))
+    , m_baudRate(baudRate) {
+    auto separator = m_device.find_last_of('/');
+    if (separator == std::string::npos) {
+        m_watchDir = ".";
+        m_deviceName = m_device;
+    } else {
+        m_watchDir = separator == 0 ? "/" : m_device.substr(0, separator);
+        m_deviceName = m_device.substr(separator + 1);
+    }
+
+    m_inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    if (m_inotifyFd < 0) {
+        std::cerr << "Failed to init inotify, polling for " << m_device << " instead" << std::endl;
+    }
+    AddWatch();
+}
+
+/**
+ * @brief Destroy the Device Supervisor:: Device Supervisor object
+ *
+ */
+DeviceSupervisor::~DeviceSupervisor() {
+    if (m_inotifyFd >= 0) {
+        close(m_inotifyFd);
+    }
+}
+
+/**
+ * @brief Make sure the device is open, waiting for it to appear if necessary.
+ * After a failure that left the device node in place, reopening is delayed by a growing
+ * backoff, unless the node is created again in the meantime
+ *
+ * @param timeout Maximum time to wait for the device
+ * @return true Device is open
+ * @return false Device is still not available
+ */
+bool DeviceSupervisor::EnsureOpen(std::chrono::milliseconds timeout) {
+    if (m_serialDevice.isDeviceOpen()) {
+        return true;
+    }
+
+    const auto deadline = TraceClock::now() + timeout;
+    while (true) {
+        auto now = TraceClock::now();
+        if (now >= m_reopenNotBefore) {
+            if (TryOpen()) {
+                return true;
+            }
+            if (!m_waitingLogged) {
+                // Tell once per outage, eg: a mistyped path or missing permissions
+                std::cout << "Waiting for the device : " << m_device << " (" << strerror(errno) << ")" << std::endl;
+                m_waitingLogged = true;
+            }
+            now = TraceClock::now();
+        }
+        if (now >= deadline) {
+            return false;
+        }
+        const auto waitUntil = now < m_reopenNotBefore ? std::min(deadline, m_reopenNotBefore) : deadline;
+        if (WaitForDevice(std::chrono::ceil<std::chrono::milliseconds>(waitUntil - now))) {
+            // The node was created again, no need to back off
+            m_reopenNotBefore = {};
+        }
+    }
+}
+
+/**
+ * @brief Check, without blocking, if the device node has been removed
+ *
+ * @return true Device node was deleted or renamed
+ * @return false No change
+ */
+bool DeviceSupervisor::DeviceRemoved() {
+    return (ReadEvents() & DeviceEvent::REMOVED) != 0;
+}
+
+/**
+ * @brief Close the device after an error or removal. The next EnsureOpen() will reopen it
+ *
+ * @param nodeRemoved true if the device node is gone, reopening then waits for it to be
+ * created again instead of backing off
+ */
+void DeviceSupervisor::MarkLost(bool nodeRemoved) {
+    if (!m_serialDevice.isDeviceOpen()) {
+        return;
+    }
+    m_serialDevice.Close();
+
+    const auto now = TraceClock::now();
+    if (!m_awaitingData) {
+        // A new outage, a reopen that never delivered data continues the previous one
+        m_downSinceNs = toNanos(now);
+        m_connected = false;
+        std::cout << "Lost the device : " << m_device << std::endl;
+    }
+    if (nodeRemoved) {
+        m_reopenNotBefore = {};
+    } else {
+        m_reopenNotBefore = now + m_backoff;
+        m_backoff = std::min(m_backoff * 2, kMaxBackoff);
+    }
+}
+
+/**
+ * @brief Tell the supervisor that the device delivered data.
+ * Confirms a pending reconnect and resets the reopen backoff
+ *
+ */
+void DeviceSupervisor::MarkDataReceived() {
+    m_backoff = kPollInterval;
+    if (!m_awaitingData) {
+        return;
+    }
+    m_awaitingData = false;
+    const auto outage = toNanos(TraceClock::now()) - m_downSinceNs.load(std::memory_order_relaxed);
+    m_downtimeNs += outage;
+    m_reconnects++;
+    m_connected = true;
+    std::cout << "Reconnected the device : " << m_device << " after " << outage / 1000000 << " ms" << std::endl;
+}
+
+/**
+ * @brief Get the total time the device was not available after it was opened for the
+ * first time, including the current outage
+ *
+ * @return TraceClock::duration Downtime
+ */
+TraceClock::duration DeviceSupervisor::Downtime() const {
+    int64_t downtime = m_downtimeNs.load(std::memory_order_relaxed);
+    if (wasOpened() && !isConnected()) {
+        downtime += toNanos(TraceClock::now()) - m_downSinceNs.load(std::memory_order_relaxed);
+    }
+    return std::chrono::duration_cast<TraceClock::duration>(std::chrono::nanoseconds(downtime));
+}
+
+/**
+ * @brief Format the connection state, reconnect count and downtime of the device
+ *
+ * @return std::string Single line report
+ */
+std::string DeviceSupervisor::Report() const {
+    std::ostringstream report;
+    report << m_device << " : " << (isConnected() ? "connected" : (wasOpened() ? "disconnected" : "not opened yet"))
+           << ", reconnects " << Reconnects()
+           << ", downtime " << std::chrono::duration_cast<std::chrono::milliseconds>(Downtime()).count() << " ms";
+    return report.str();
+}
+
+/**
+ * @brief Open the device and update the statistics on success
+ *
+ * @return true Device opened
+ * @return false Device is not available
+ */
+bool DeviceSupervisor::TryOpen() {
+    if (!m_serialDevice.Open(m_device, m_baudRate)) {
+        return false;
+    }
+    m_serialDevice.Flush();
+
+    m_waitingLogged = false;
+    if (m_wasOpened) {
+        // Only counted as a reconnect once data arrives, see MarkDataReceived()
+        if (!m_awaitingData) {
+            std::cout << "Reopened the device : " << m_device << ", waiting for data" << std::endl;
+        }
+        m_awaitingData = true;
+    } else {
+        std::cout << "Opened the device : " << m_device << std::endl;
+        m_connected = true;
+        m_wasOpened = true;
+    }
+    return true;
+}
+
+/**
+ * @brief Start watching the directory of the device node
+ *
+ * @return true Watch is active
+ * @return false Directory could not be watched (eg: /dev/serial/by-id does not exist yet)
+ */
+bool DeviceSupervisor::AddWatch() {
+    if (m_inotifyFd < 0) {
+        return false;
+    }
+    if (m_watch < 0) {
+        m_watch = inotify_add_watch(m_inotifyFd, m_watchDir.c_str(),
+                                    IN_CREATE | IN_ATTRIB | IN_MOVED_TO | IN_DELETE | IN_MOVED_FROM | IN_DELETE_SELF | IN_MOVE_SELF);
+    }
+    return m_watch >= 0;
+}
+
+/**
+ * @brief Drain all the pending inotify events without blocking
+ *
+ * @return int DeviceEvent flags seen for our device node
+ */
+int DeviceSupervisor::ReadEvents() {
+    if (m_inotifyFd < 0) {
+        return DeviceEvent::NONE;
+    }
+
+    int events = DeviceEvent::NONE;
+    alignas(inotify_event) char buffer[4096];
+    while (true) {
+        auto length = read(m_inotifyFd, buffer, sizeof(buffer));
+        if (length <= 0) {
+            // EAGAIN, nothing more to read
+            break;
+        }
+        for (char *ptr = buffer; ptr < buffer + length;) {
+            auto *event = reinterpret_cast<inotify_event *>(ptr);
+            ptr += sizeof(inotify_event) + event->len;
+
+            if (event->mask & (IN_DELETE_SELF | IN_MOVE_SELF | IN_IGNORED)) {
+                // The watched directory itself went away, eg: last by-id link removed
+                if (event->mask & IN_IGNORED) {
+                    m_watch = -1;
+                }
+                events |= DeviceEvent::REMOVED;
+                continue;
+            }
+            if (event->len == 0 || m_deviceName.compare(event->name) != 0) {
+                continue;
+            }
+            if (event->mask & (IN_CREATE | IN_ATTRIB | IN_MOVED_TO)) {
+                events |= DeviceEvent::APPEARED;
+            }
+            if (event->mask & (IN_DELETE | IN_MOVED_FROM)) {
+                events |= DeviceEvent::REMOVED;
+            }
+        }
+    }
+    return events;
+}
+
+/**
+ * @brief Block until the device node appears or timeout.
+ * Falls back to polling when the directory can't be watched
+ *
+ * @param timeout Maximum time to wait
+ * @return true The device node was created
+ * @return false Timeout, or not known while polling
+ */
+bool DeviceSupervisor::WaitForDevice(std::chrono::milliseconds timeout) {
+    if (!AddWatch()) {
+        std::this_thread::sleep_for(std::min<std::chrono::milliseconds>(timeout, kPollInterval));
+        return false;
+    }
+
+    const auto deadline = TraceClock::now() + timeout;
+    while (true) {
+        auto remaining = std::chrono::duration_cast<std::chrono::milliseconds>(deadline - TraceClock::now());
+        if (remaining.count() <= 0) {
+            return false;
+        }
+        pollfd pfd = {m_inotifyFd, POLLIN, 0};
+        if (poll(&pfd, 1, static_cast<int>(remaining.count())) <= 0) {
+            // Timeout or interrupted
+            return false;
+        }
+        auto events = ReadEvents();
+        if (events & DeviceEvent::APPEARED) {
+            return true;
+        }
+        if (m_watch < 0) {
+            return false;
+        }
+    }
+}
+
+}  // namespace
@@ -0,0 +1,131 @@
+#include <latency_tracer.h>
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+namespace PacificScales {
+
+/**
+ * @brief Map a value to its log-linear bucket.
+ * Values below kSubBuckets get their own bucket, larger values keep only
+ * their top kSubBucketBits + 1 significant bits.
+ *
+ * @param value Latency in nanoseconds
+ * @return size_t Index into the bucket array
+ */
+size_t LatencyHistogram::BucketIndex(uint64_t value) {
+    value = std::min<uint64_t>(value, (1ULL << kMaxValueBits) - 1);
+    if (value < kSubBuckets) {
+        return value;
+    }
+    unsigned msb = 63 - __builtin_clzll(value);
+    unsigned shift = msb - kSubBucketBits;
+    return shift * kSubBuckets + (value >> shift);
+}
+
+/**
+ * @brief Get the largest value that maps to the given bucket
+ *
+ * @param index Bucket index
+ * @return uint64_t Upper bound of the bucket in nanoseconds
+ */
+uint64_t LatencyHistogram::BucketUpperBound(size_t index) {
+    if (index < kSubBuckets) {
+        return index;
+    }
+    uint64_t shift = index / kSubBuckets - 1;
+    uint64_t subBucket = kSubBuckets + index % kSubBuckets;
+    return ((subBucket + 1) << shift) - 1;
+}
+
+/**
+ * @brief Record a single latency sample. Lock-free, safe to call from any thread
+ *
+ * @param latency Measured latency, negative values are recorded as zero
+ */
+void LatencyHistogram::Record(TraceClock::duration latency) {
+    auto nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(latency).count();
+    uint64_t value = nanos > 0 ? static_cast<uint64_t>(nanos) : 0;
+
+    m_buckets[BucketIndex(value)].fetch_add(1, std::memory_order_relaxed);
+    m_count.fetch_add(1, std::memory_order_relaxed);
+
+    uint64_t currentMax = m_max.load(std::memory_order_relaxed);
+    while (value > currentMax && !m_max.compare_exchange_weak(currentMax, value, std::memory_order_relaxed)) {
+    }
+}
+
+/**
+ * @brief Get the value at the given percentile.
+ * Concurrent Record() calls may or may not be included in the result.
+ *
+ * @param percentile Percentile in the range 0 - 100, eg: 99.9
+ * @return uint64_t Latency in nanoseconds, 0 if nothing was recorded
+ */
+uint64_t LatencyHistogram::Percentile(double percentile) const {
+    uint64_t total = 0;
+    std::array<uint64_t, kNumBuckets> counts;
+    for (size_t i = 0; i < kNumBuckets; i++) {
+        counts[i] = m_buckets[i].load(std::memory_order_relaxed);
+        total += counts[i];
+    }
+    if (total == 0) {
+        return 0;
+    }
+
+    auto target = static_cast<uint64_t>(std::ceil(percentile / 100.0 * total));
+    target = std::clamp<uint64_t>(target, 1, total);
+    uint64_t seen = 0;
+    for (size_t i = 0; i < kNumBuckets; i++) {
+        seen += counts[i];
+        if (seen >= target) {
+            return std::min(BucketUpperBound(i), Max());
+        }
+    }
+    return Max();
+}
+
+/**
+ * @brief Record the stage-to-stage deltas of a completed frame
+ *
+ * @param trace Timestamps of the frame
+ */
+void LatencyTracer::Record(const FrameTrace &trace) {
+    m_receiveToDelimiter.Record(trace.delimited - trace.received);
+    m_delimiterToPublished.Record(trace.published - trace.delimited);
+    m_endToEnd.Record(trace.published - trace.received);
+}
+
+/**
+ * @brief Format p50/p99/p999 and max of every stage as a table
+ *
+ * @return std::string Latency report, values in microseconds
+ */
+std::string LatencyTracer::Report() const {
+    std::ostringstream report;
+    auto printRow = [&](const char *stage, const LatencyHistogram &histogram) {
+        report << std::left << std::setw(22) << stage << std::right
+               << std::setw(10) << histogram.Count()
+               << std::setw(12) << histogram.Percentile(50.0) / 1000
+               << std::setw(12) << histogram.Percentile(99.0) / 1000
+               << std::setw(12) << histogram.Percentile(99.9) / 1000
+               << std::setw(12) << histogram.Max() / 1000 << std::endl;
+    };
+
+    report << "Frame latency (us)" << std::endl;
+    report << std::left << std::setw(22) << "stage" << std::right
+           << std::setw(10) << "count"
+           << std::setw(12) << "p50"
+           << std::setw(12) << "p99"
+           << std::setw(12) << "p999"
+           << std::setw(12) << "max" << std::endl;
+    printRow("receive->delimiter", m_receiveToDelimiter);
+    printRow("delimiter->published", m_delimiterToPublished);
+    printRow("receive->published", m_endToEnd);
+
+    return report.str();
+}
+
+}  // namespace
@@ -1,22 +1,52 @@
 #include <atomic>
 #include <chrono>
 #include <iostream>
+#include <list>
 #include <serial_device.h>
 #include <sstream>
 #include <string.h>
 #include <thread>
+#include <vector>
 
 #include <circular_buffer.h>
+#include <device_supervisor.h>
 #include <getopt.h>
+#include <latency_tracer.h>
+#include <platform_aggregator.h>
 #include <scale_data_parser.h>
 #include <signal.h>
 
-PacificScales::ScaleDataParser g_scaledataParser;
-PacificScales::CircularBuffer<uint8_t, 8192> g_dataBuffer;
+/**
+ * @brief Everything needed to read and parse one serial device
+ */
+struct DevicePipeline {
+    DevicePipeline(const std::string &device, PacificScales::BaudRate baudRate)
+        : device(device)
+        , supervisor(device, baudRate) { }
+
+    std::string device;
+    PacificScales::DeviceSupervisor supervisor;
+    PacificScales::CircularBuffer<uint8_t, 8192> dataBuffer;
+    PacificScales::ScaleDataParser scaledataParser;
+};
+
+PacificScales::LatencyTracer g_latencyTracer;
 std::atomic<bool> keepRunning = {true};
+std::atomic<bool> latencyReportRequested = {false};
 
 static constexpr PacificScales::BaudRate kDEFAULT_BAUD_RATE = PacificScales::BaudRate::BAUD_115200;
 static constexpr const char *kDEFAULT_UART_DEVICE = "/dev/ttyUSB0";
+static constexpr int kDEFAULT_LATENCY_REPORT_INTERVAL = 0;
+static constexpr int kDEFAULT_SKEW_WINDOW_MS = 500;
+static constexpr int kDEFAULT_PLATFORM_WAIT_MS = 1000;
+
+struct CommandlineArgs {
+    std::vector<std::string> devices;  // One per weighbridge platform
+    PacificScales::BaudRate baudRate = kDEFAULT_BAUD_RATE;
+    int skewWindowMs = kDEFAULT_SKEW_WINDOW_MS;
+    int platformWaitMs = kDEFAULT_PLATFORM_WAIT_MS;  // Extra wait for late platforms
+    int latencyReportInterval = kDEFAULT_LATENCY_REPORT_INTERVAL;  // Seconds, 0 to disable
+};
 
 /**
  * @brief Signal handler for Ctrl-C
@@ -26,43 +56,77 @@ void SignalHandler(int) {
 }
 
 /**
- * @brief Thread for reading data from Serial Device
- * @param device Full path to the device file
+ * @brief Signal handler for SIGUSR1, requests a latency and device report
  */
-void DataReaderThread(const std::string device, PacificScales::BaudRate baudRate) {
-    PacificScales::SerialDevice dev;
-    if (!dev.Open(device, baudRate)) {
-        std::cout << "Error: Failed to open device : " << device << "@B" << baudRate << std::endl;
-        keepRunning = false;
-        return;
-    }
-    std::cout << "Opened the device : " << device << std::endl;
-    dev.Flush();
+void LatencyReportSignalHandler(int) {
+    latencyReportRequested = true;
+}
+
+/**
+ * @brief Thread for reading data from Serial Device.
+ * The device is reopened by its supervisor whenever it is unplugged and plugged back,
+ * the buffer and parser state of the pipeline are kept
+ * @param pipeline Pipeline of the device to read
+ */
+void DataReaderThread(DevicePipeline &pipeline) {
+    auto &supervisor = pipeline.supervisor;
+    auto &dev = supervisor.Device();
     while (keepRunning) {
-        auto block = g_dataBuffer.GetDataBlock();
-        auto numRead = dev.Read(block.data(), block.size(), std::chrono::seconds(1));
-        if (numRead <= 0) {
-            // EAGAIN
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+        // Wait in short steps so that shutdown is not delayed
+        if (!supervisor.EnsureOpen(std::chrono::seconds(1))) {
             continue;
         }
-        // std::cout << "Got " << numRead << " bytes of data" << std::endl;
-        block.MarkFilled(numRead);
+        auto block = pipeline.dataBuffer.GetDataBlock();
+        PacificScales::TraceClock::time_point firstByteAt;
+        auto numRead = dev.Read(block.data(), block.size(), std::chrono::seconds(1), &firstByteAt);
+        if (numRead > 0) {
+            // std::cout << "Got " << numRead << " bytes of data" << std::endl;
+            block.MarkFilled(numRead, firstByteAt);
+            supervisor.MarkDataReceived();
+        }
+        const bool removed = supervisor.DeviceRemoved();
+        if (numRead < 0 || removed) {
+            // Read error, hangup or the device node is gone
+            supervisor.MarkLost(removed);
+            // Don't stitch the data from before the outage to the data after it
+            pipeline.dataBuffer.StartNewGeneration();
+        }
     }
 }
 
 /**
  * @brief Thread for parsing data from circular buffer
+ * @param pipeline Pipeline of the device to parse
   */
-void DataParserThread() {
+void DataParserThread(DevicePipeline &pipeline) {
+    uint32_t generation = 0;
     while (keepRunning) {
-        auto str = g_dataBuffer.GetLine();
+        PacificScales::TraceClock::time_point received;
+        uint32_t lineGeneration = 0;
+        auto str = pipeline.dataBuffer.GetLine(&received, &lineGeneration);
+        auto delimited = PacificScales::TraceClock::now();
         if (str.empty()) {
             // std::cout << "Buffer empty, waiting for data" << std::endl;
             std::this_thread::sleep_for(std::chrono::milliseconds(500));
             continue;
         }
-        g_scaledataParser.ParseLine(str);
+        if (lineGeneration != generation) {
+            // First line after the device was reconnected, drop the frame from before the outage
+            generation = lineGeneration;
+            pipeline.scaledataParser.Reset();
+        }
+        pipeline.scaledataParser.ParseLine(str, received, delimited);
+    }
+}
+
+/**
+ * @brief Thread for combining the frames of all the platforms
+ * @param aggregator Aggregator fed by the parser threads
+ */
+void AggregatorThread(PacificScales::PlatformAggregator &aggregator) {
+    while (keepRunning) {
+        aggregator.Process(PacificScales::TraceClock::now());
+        std::this_thread::sleep_for(std::chrono::milliseconds(10));
     }
 }
 
@@ -79,31 +143,64 @@ void ShowHelpScreen(std::string appName) {
     std::cout << "Parse scale data and show every 10 secs as JSON" << std::endl
               << "Arguments" << std::endl
               << "\t -p <serial_port_device> [" << kDEFAULT_UART_DEVICE << "]" << std::endl
-              << "\t -b <baud_rate> [" << kDEFAULT_BAUD_RATE << "]" << std::endl;
+              << "\t    Repeat -p for every platform of a multi-platform weighbridge" << std::endl
+              << "\t -b <baud_rate> [" << kDEFAULT_BAUD_RATE << "]" << std::endl
+              << "\t -s <platform_skew_window_ms> [" << kDEFAULT_SKEW_WINDOW_MS << "]" << std::endl
+              << "\t -w <platform_wait_ms> [" << kDEFAULT_PLATFORM_WAIT_MS << "]" << std::endl
+              << "\t -l <latency_report_interval_secs> [" << kDEFAULT_LATENCY_REPORT_INTERVAL << "]" << std::endl
+              << "Send SIGUSR1 to print the frame latency and device report at any time" << std::endl;
+}
+
+/**
+ * @brief Print the frame latencies and the connection statistics of every device
+ * @param pipelines All the device pipelines
+ */
+void PrintStatusReport(const std::list<DevicePipeline> &pipelines) {
+    std::cout << g_latencyTracer.Report() << "Devices" << std::endl;
+    for (auto &pipeline : pipelines) {
+        std::cout << pipeline.supervisor.Report() << std::endl;
+    }
+    std::cout << std::endl;
 }
 
 /**
  * @brief Function to parse commandline args
   * @param argc Argument Count
  * @param argv  Argument Vector
- * @return std::pair<std::string, PacificScales::BaudRate>
+ * @return CommandlineArgs
  */
-std::pair<std::string, PacificScales::BaudRate> ParseCommandlineArgs(int argc, char *argv[]) {
-    auto device = std::string(kDEFAULT_UART_DEVICE);
-    PacificScales::BaudRate baudRate = kDEFAULT_BAUD_RATE;
+CommandlineArgs ParseCommandlineArgs(int argc, char *argv[]) {
+    CommandlineArgs args;
 
     int opt = 0;
     do {
-        opt = getopt(argc, argv, "hp:b:");
+        opt = getopt(argc, argv, "hp:b:s:w:l:");
         switch (opt) {
         case -1:
             break;
         case 'p':
-            device = std::string(optarg);
+            args.devices.push_back(std::string(optarg));
             continue;
             ;
         case 'b':
-            baudRate = static_cast<PacificScales::BaudRate>(std::atoi(optarg));
+            args.baudRate = static_cast<PacificScales::BaudRate>(std::atoi(optarg));
+            continue;
+        case 's':
+            args.skewWindowMs = std::atoi(optarg);
+            if (args.skewWindowMs <= 0) {
+                std::cout << "Error: Skew window must be greater than 0 ms" << std::endl;
+                exit(1);
+            }
+            continue;
+        case 'w':
+            args.platformWaitMs = std::atoi(optarg);
+            if (args.platformWaitMs < 0) {
+                std::cout << "Error: Platform wait must not be negative" << std::endl;
+                exit(1);
+            }
+            continue;
+        case 'l':
+            args.latencyReportInterval = std::atoi(optarg);
             continue;
         case 'h':
         default:
@@ -112,7 +209,10 @@ std::pair<std::string, PacificScales::BaudRate> ParseCommandlineArgs(int argc, c
         }
     } while (opt != -1);
 
-    return {device, baudRate};
+    if (args.devices.empty()) {
+        args.devices.push_back(kDEFAULT_UART_DEVICE);
+    }
+    return args;
 }
 
 /**
@@ -122,13 +222,42 @@ std::pair<std::string, PacificScales::BaudRate> ParseCommandlineArgs(int argc, c
 int main(int argc, char *argv[]) {
     // setup signal handlers
     signal(SIGINT, SignalHandler);
+    signal(SIGUSR1, LatencyReportSignalHandler);
 
     // Parse commandline args
-    auto [device, baudRate] = ParseCommandlineArgs(argc, argv);
+    auto args = ParseCommandlineArgs(argc, argv);
+    if (!PacificScales::SerialDevice::isSupportedBaudRate(args.baudRate)) {
+        std::cout << "Error: Unsupported baud rate : " << args.baudRate << std::endl;
+        return 1;
+    }
+
+    // CircularBuffer can't be moved, so keep the pipelines in a list
+    std::list<DevicePipeline> pipelines;
+    for (auto &device : args.devices) {
+        pipelines.emplace_back(device, args.baudRate);
+    }
 
-    std::thread readerThread(DataReaderThread, device, baudRate);
-    std::thread parserThread(DataParserThread);
+    // Combine the platforms only when there is more than one
+    const bool aggregate = pipelines.size() > 1;
+    PacificScales::PlatformAggregator aggregator(args.devices, std::chrono::milliseconds(args.skewWindowMs),
+                                                 std::chrono::milliseconds(args.platformWaitMs));
+
+    std::vector<std::thread> threads;
+    size_t platform = 0;
+    for (auto &pipeline : pipelines) {
+        pipeline.scaledataParser.SetLatencyTracer(&g_latencyTracer);
+        if (aggregate) {
+            pipeline.scaledataParser.SetFrameListener(aggregator.Input(platform));
+        }
+        threads.emplace_back(DataReaderThread, std::ref(pipeline));
+        threads.emplace_back(DataParserThread, std::ref(pipeline));
+        platform++;
+    }
+    if (aggregate) {
+        threads.emplace_back(AggregatorThread, std::ref(aggregator));
+    }
 
+    auto nextLatencyReport = std::chrono::steady_clock::now() + std::chrono::seconds(args.latencyReportInterval);
     while (keepRunning) {
         auto now = std::chrono::system_clock::now();
         auto secs = getCurrentSeconds(now);
@@ -136,7 +265,18 @@ int main(int argc, char *argv[]) {
             const std::time_t t_c = std::chrono::system_clock::to_time_t(now);
             std::cout << "Latest weight data for: " << std::ctime(&t_c) << std::endl;
             // Print the latest scale data
-            std::cout << g_scaledataParser.Latest().toJson() << std::endl;
+            if (aggregate) {
+                std::cout << aggregator.Latest().toJson() << std::endl;
+            } else {
+                std::cout << pipelines.front().scaledataParser.Latest().toJson() << std::endl;
+            }
+        }
+        if (args.latencyReportInterval > 0 && std::chrono::steady_clock::now() >= nextLatencyReport) {
+            nextLatencyReport += std::chrono::seconds(args.latencyReportInterval);
+            latencyReportRequested = true;
+        }
+        if (latencyReportRequested.exchange(false)) {
+            PrintStatusReport(pipelines);
         }
         // Sleep only 1 second. Longer sleep duration - especially if sleeping all the
         // way to next time boundary will cause an unfriendly delay while shutting down
@@ -144,7 +284,9 @@ int main(int argc, char *argv[]) {
     }
 
     std::cout << "Shutting down " << std::endl;
-    readerThread.join();
-    parserThread.join();
+    for (auto &thread : threads) {
+        thread.join();
+    }
+    PrintStatusReport(pipelines);
     return 0;
 }
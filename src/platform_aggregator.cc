@@ -0,0 +1,214 @@
+#include <platform_aggregator.h>
+
+#include <algorithm>
+#include <iostream>
+#include <sstream>
+
+namespace PacificScales {
+
+/**
+ * @brief Add the reading of a single platform to the slot
+ *
+ * @param name Name of the platform
+ * @param frame Frame of the platform within the slot
+ * @param present false if the platform had no frame within the slot
+ */
+void AggregatedData::AddPlatform(std::string name, const PlatformFrame &frame, bool present) {
+    m_platforms.push_back({std::move(name), frame, present});
+}
+
+/**
+ * @brief Get the combined gross weight of all the platforms
+ *
+ * @return int64_t Sum of TOTAL of every platform present in the slot
+ */
+int64_t AggregatedData::Gross() const {
+    int64_t gross = 0;
+    for (auto &platform : m_platforms) {
+        if (platform.present) {
+            gross += platform.frame.total;
+        }
+    }
+    return gross;
+}
+
+/**
+ * @brief Check if every platform is present and valid in this slot
+ *
+ * @return true All the platforms have a valid reading
+ * @return false Otherwise
+ */
+bool AggregatedData::isValid() const {
+    if (m_platforms.empty()) {
+        return false;
+    }
+    return std::all_of(m_platforms.begin(), m_platforms.end(), [](const PlatformReading &platform) {
+        return platform.present && platform.frame.valid;
+    });
+}
+
+/**
+ * @brief Convert AggregatedData to Json String
+ *
+ * @return std::string formatted JSON string with per-platform breakdown
+ */
+std::string AggregatedData::toJson() const {
+    std::ostringstream jsonPrinter;
+    jsonPrinter << "{" << std::endl;
+    jsonPrinter << "  \"PLATFORMS\" : {" << std::endl;
+    for (size_t i = 0; i < m_platforms.size(); i++) {
+        auto &platform = m_platforms[i];
+        auto skew = std::chrono::duration_cast<std::chrono::milliseconds>(platform.frame.timestamp - m_timestamp);
+        jsonPrinter << "    \"" << platform.name << "\" : { "
+                    << "\"TOTAL\" : " << platform.frame.total << ", "
+                    << "\"VALID\" : " << (platform.present && platform.frame.valid ? "true" : "false") << ", "
+                    << "\"PRESENT\" : " << (platform.present ? "true" : "false");
+        if (platform.present) {
+            jsonPrinter << ", \"SKEW_MS\" : " << skew.count();
+        }
+        jsonPrinter << " }" << (i + 1 < m_platforms.size() ? "," : "") << std::endl;
+    }
+    jsonPrinter << "  }," << std::endl;
+    jsonPrinter << "  \"GROSS\" : " << Gross() << "," << std::endl;
+    jsonPrinter << "  \"VALID\" : " << (isValid() ? "true" : "false") << std::endl;
+    jsonPrinter << "}" << std::endl;
+
+    return jsonPrinter.str();
+}
+
+/**
+ * @brief Construct a new Platform Aggregator
+ *
+ * @param platformNames Name of every platform, the index is used with Input() and Submit()
+ * @param skewWindow Maximum time difference between frames of the same slot
+ * @param lateness How long after the first frame of a slot reached the aggregator
+ * to wait for the other platforms, on top of the skew window
+ */
+PlatformAggregator::PlatformAggregator(std::vector<std::string> platformNames, std::chrono::milliseconds skewWindow,
+                                       std::chrono::milliseconds lateness)
+    : m_platformNames(std::move(platformNames))
+    , m_skewWindow(skewWindow)
+    , m_lateness(lateness)
+    , m_pending(m_platformNames.size()) {
+    for (size_t i = 0; i < m_platformNames.size(); i++) {
+        m_queues.push_back(std::make_unique<FrameQueue>());
+        m_inputs.push_back(std::make_unique<PlatformInput>(this, i));
+    }
+}
+
+/**
+ * @brief Get the listener to attach to the parser of a platform
+ *
+ * @param platform Index of the platform
+ * @return FrameListener* Listener, owned by the aggregator
+ */
+FrameListener *PlatformAggregator::Input(size_t platform) {
+    return platform < m_inputs.size() ? m_inputs[platform].get() : nullptr;
+}
+
+void PlatformAggregator::PlatformInput::OnFrame(const ScaleData &data) {
+    m_aggregator->Submit(m_platform, {data.Total(), data.isValid(), data.Timestamp()});
+}
+
+/**
+ * @brief Hand over a new frame from a platform. Lock-free and allocation free,
+ * but each platform must only be submitted from a single thread
+ *
+ * @param platform Index of the platform
+ * @param frame Summary of the parsed frame
+ * @return true Frame queued
+ * @return false Queue full or invalid platform, frame dropped
+ */
+bool PlatformAggregator::Submit(size_t platform, const PlatformFrame &frame) {
+    if (platform >= m_queues.size()) {
+        return false;
+    }
+    if (!m_queues[platform]->Push(frame)) {
+        std::cerr << "Aggregator queue full, dropping frame from " << m_platformNames[platform] << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Collect the queued frames and emit every slot that is settled.
+ * A slot is settled once every platform has a frame at or after the slot, or when the
+ * platforms without one are later than the skew window plus the lateness allowance,
+ * counted from when the first frame of the slot reached the aggregator
+ *
+ * @param now Current monotonic time
+ */
+void PlatformAggregator::Process(TraceClock::time_point now) {
+    for (size_t i = 0; i < m_queues.size(); i++) {
+        PlatformFrame frame;
+        while (m_queues[i]->Pop(frame)) {
+            m_pending[i].push_back({frame, now});
+        }
+    }
+    DropStaleFrames();
+
+    while (true) {
+        // Anchor the slot on the oldest pending frame
+        const PendingFrame *anchor = nullptr;
+        bool settled = true;
+        for (auto &pending : m_pending) {
+            if (pending.empty()) {
+                settled = false;
+            } else if (!anchor || pending.front().frame.timestamp < anchor->frame.timestamp) {
+                anchor = &pending.front();
+            }
+        }
+        if (!anchor) {
+            return;
+        }
+
+        // Every platform with a pending frame is known to have nothing older,
+        // only the platforms without one may still deliver a frame for this slot
+        if (!settled && now < anchor->arrival + m_skewWindow + m_lateness) {
+            return;
+        }
+
+        const auto slotStart = anchor->frame.timestamp;
+        const auto windowEnd = slotStart + m_skewWindow;
+        AggregatedData slot(slotStart);
+        for (size_t i = 0; i < m_pending.size(); i++) {
+            auto &pending = m_pending[i];
+            if (!pending.empty() && pending.front().frame.timestamp <= windowEnd) {
+                slot.AddPlatform(m_platformNames[i], pending.front().frame, true);
+                pending.pop_front();
+            } else {
+                slot.AddPlatform(m_platformNames[i], {}, false);
+            }
+        }
+        m_lastWindowEnd = windowEnd;
+        DropStaleFrames();
+        UpdateLatest(slot);
+    }
+}
+
+/**
+ * @brief Drop the frames that belong to an already emitted slot, they
+ * arrived too late or are extra frames of the same platform within the window
+ *
+ */
+void PlatformAggregator::DropStaleFrames() {
+    if (m_lastWindowEnd == TraceClock::time_point {}) {
+        return;
+    }
+    for (auto &pending : m_pending) {
+        while (!pending.empty() && pending.front().frame.timestamp <= m_lastWindowEnd) {
+            pending.pop_front();
+        }
+    }
+}
+
+void PlatformAggregator::UpdateLatest(const AggregatedData latest) {
+    const std::lock_guard<std::mutex> lock(m_mutex);
+    // Never go back to an older slot
+    if (latest.Timestamp() < m_latest.Timestamp()) {
+        return;
+    }
+    m_latest = latest;
+}
+
+}  // namespace
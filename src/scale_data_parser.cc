@@ -62,24 +62,46 @@ void ScaleData::AddDataChannel(std::string channel, int32_t mass) {
 }
 
 /**
- * @brief Convert ScaleData to Json String
+ * @brief Check if the reported TOTAL matches the sum of all the channels
  *
- * @return std::string formatted JSON string of scale data
+ * @return true TOTAL is present and matches
+ * @return false Otherwise
  */
-std::string ScaleData::toJson() const {
-    std::ostringstream jsonPrinter;
+bool ScaleData::isValid() const {
     int totalCalculated = 0;
     int totalFromData = -1;
-    jsonPrinter << "{" << std::endl;
     for (auto &itr : m_channelMassMap) {
         if (itr.first.compare("TOTAL") == 0) {
             totalFromData = itr.second;
         } else {
             totalCalculated += itr.second;
         }
+    }
+    return totalFromData == totalCalculated;
+}
+
+/**
+ * @brief Get the total mass of all the channels
+ *
+ * @return int32_t TOTAL reported by the scale, or 0 if there is none
+ */
+int32_t ScaleData::Total() const {
+    auto total = m_channelMassMap.find("TOTAL");
+    return total == m_channelMassMap.end() ? 0 : total->second;
+}
+
+/**
+ * @brief Convert ScaleData to Json String
+ *
+ * @return std::string formatted JSON string of scale data
+ */
+std::string ScaleData::toJson() const {
+    std::ostringstream jsonPrinter;
+    jsonPrinter << "{" << std::endl;
+    for (auto &itr : m_channelMassMap) {
         jsonPrinter << "  \"" << itr.first << "\" : " << itr.second << "," << std::endl;
     }
-    auto valid = (totalFromData == totalCalculated) ? "true" : "false";
+    auto valid = isValid() ? "true" : "false";
     jsonPrinter << "  \"VALID\" : " << valid << std::endl;
     jsonPrinter << "}" << std::endl;
 
@@ -91,32 +113,57 @@ std::string ScaleData::toJson() const {
  * When a full set of data is parsed, the 'latest' will be updated
  *
  * @param line Line to be parsed
+ * @param received Time the first byte of the line was read from the device
+ * @param delimited Time the line was extracted from the input buffer
  */
-void ScaleDataParser::ParseLine(std::string line) {
+void ScaleDataParser::ParseLine(std::string line, TraceClock::time_point received, TraceClock::time_point delimited) {
     line = trim(line);
     if (line.empty()) {
         return;
     }
+    if (m_parserState == ParserState::RESYNC && line.compare("/") != 0) {
+        // Rest of the block that was interrupted
+        return;
+    }
     if (line.compare("/") == 0) {
         // Start of block
-        if (m_parserState != ParserState::UNKNOWN && m_parserState != ParserState::FINISHED) {
+        if (m_parserState != ParserState::UNKNOWN && m_parserState != ParserState::FINISHED
+            && m_parserState != ParserState::RESYNC) {
             std::cerr << "Parsing error: Invalid state" << std::endl;
         }
         m_parserState = ParserState::STARTED;
         m_current = {};
+        m_trace = {};
+        m_trace.received = received;
         return;
     }
     if (line.compare("\\") == 0) {
         // end of block
         if (m_parserState == ParserState::TOTAL_PARSED) {
+            // The channels are parsed line by line, so the frame is complete as soon as its end is seen
+            m_trace.delimited = delimited != TraceClock::time_point {} ? delimited : TraceClock::now();
+            m_current.SetTimestamp(m_trace.received != TraceClock::time_point {} ? m_trace.received : m_trace.delimited);
             UpdateLatest(m_current);
+            m_trace.published = TraceClock::now();
+            // Frames without timestamps are not traced
+            if (m_tracer && m_trace.received != TraceClock::time_point {} && delimited != TraceClock::time_point {}) {
+                m_tracer->Record(m_trace);
+            }
+            if (m_frameListener) {
+                m_frameListener->OnFrame(m_current);
+            }
         } else {
             std::cerr << "Parsing error: Invalid state" << std::endl;
         }
         m_parserState = ParserState::FINISHED;
         m_current = {};
+        m_trace = {};
         return;
     }
+    if (m_trace.received == TraceClock::time_point {}) {
+        // Start of the block was not seen, the frame starts with this line
+        m_trace.received = received;
+    }
     if (line.find(":") != std::string::npos) {
         auto tokens = split(line, ":");
         auto channelName = tokens[0];
@@ -129,6 +176,17 @@ void ScaleDataParser::ParseLine(std::string line) {
     }
 }
 
+/**
+ * @brief Drop the frame in progress, eg: when the device was reconnected in the middle of it.
+ * Lines are ignored till the start of the next block. Latest() is kept
+ *
+ */
+void ScaleDataParser::Reset() {
+    m_parserState = ParserState::RESYNC;
+    m_current = {};
+    m_trace = {};
+}
+
 void ScaleDataParser::UpdateLatest(const ScaleData latest) {
     const std::lock_guard<std::mutex> lock(m_mutex);
     m_latest = latest;
@@ -6,7 +6,6 @@
 
 #include <chrono>
 #include <map>
-#include <thread>
 
 namespace PacificScales {
 
@@ -32,13 +31,24 @@ SerialDevice::~SerialDevice() {
     Close();
 }
 
+/**
+ * @brief Check if the baud rate can be used with Open()
+ *
+ * @param baudRate Baud rate to check
+ * @return true Supported
+ * @return false Not supported
+ */
+bool SerialDevice::isSupportedBaudRate(BaudRate baudRate) {
+    return baudMap.find(baudRate) != baudMap.end();
+}
+
 /**
  * @brief Open the Serial device
  *
  * @param device  Fill path of the serial device, eg: '/dev/ttyUSB0'
  * @param baudRate One of the supported baud rates
  * @return true if Device Open was success
- * @return false  Failure
+ * @return false  Failure, including paths that are not terminals
  */
 bool SerialDevice::Open(const std::string device, BaudRate baudRate) {
     termios options = {};
@@ -62,8 +72,11 @@ bool SerialDevice::Open(const std::string device, BaudRate baudRate) {
     // Set the nodelay option
     fcntl(m_fd, F_SETFL, FNDELAY);
 
-    // read the current terminal options
-    tcgetattr(m_fd, &options);
+    // read the current terminal options, fails if this is not a terminal
+    if (tcgetattr(m_fd, &options) < 0) {
+        CloseKeepingErrno();
+        return false;
+    }
 
     cfsetispeed(&options, baud->second);
     cfsetospeed(&options, baud->second);
@@ -72,7 +85,10 @@ bool SerialDevice::Open(const std::string device, BaudRate baudRate) {
     options.c_cflag |= (CLOCAL | CREAD | CS8);
     options.c_iflag |= (IGNPAR | IGNBRK);
 
-    tcsetattr(m_fd, TCSANOW, &options);
+    if (tcsetattr(m_fd, TCSANOW, &options) < 0) {
+        CloseKeepingErrno();
+        return false;
+    }
 
     return true;
 }
@@ -82,23 +98,38 @@ bool SerialDevice::Open(const std::string device, BaudRate baudRate) {
  * Closes the serial device and reset the internal file desc
  */
 void SerialDevice::Close() {
-    close(m_fd);
+    if (m_fd >= 0) {
+        close(m_fd);
+    }
     m_fd = -1;
 }
 
 /**
- * @brief Read data from a serial device
+ * @brief Close after a failed Open, so that the caller can still report the original errno
+ *
+ */
+void SerialDevice::CloseKeepingErrno() {
+    int errsv = errno;
+    Close();
+    errno = errsv;
+}
+
+/**
+ * @brief Read data from a serial device.
+ * Returns as soon as some data has been read, so that every read() gets its own timestamp
  *
  * @param buffer  - Pointer to a buffer to read data into
  * @param bufferSize  - remaining free size of buffer
  * @param timeout  - maximum timeout while waiting for data
- * @return int  - number of bytes read. < 0 on Error
+ * @param firstByteAt  - optional, set to the time the data was read
+ * @return int  - number of bytes read. < 0 on Error or if the device was hung up
  */
-int SerialDevice::Read(void *dataBuffer, unsigned int bufferSize, std::chrono::milliseconds timeout) {
+int SerialDevice::Read(void *dataBuffer, unsigned int bufferSize, std::chrono::milliseconds timeout,
+                       std::chrono::steady_clock::time_point *firstByteAt) {
     const auto startTime = std::chrono::system_clock::now();
     unsigned int totalBytesRead = 0;
 
-    // Read data till timeout or dataBuffer full
+    // Wait for data till timeout
     do {
         unsigned char *buff = (unsigned char *)dataBuffer + totalBytesRead;
 
@@ -110,20 +141,26 @@ int SerialDevice::Read(void *dataBuffer, unsigned int bufferSize, std::chrono::m
         // Error while reading
         if (bytesRead < 0) {
             int errsv = errno;
+            if (errsv == EAGAIN || errsv == EWOULDBLOCK || errsv == EINTR) {
+                // Spurious wakeup, wait again
+                continue;
+            }
             std::cout << "Read Error : " << errsv << std::endl;
-            return bytesRead;
+            return totalBytesRead > 0 ? static_cast<int>(totalBytesRead) : bytesRead;
         }
 
         if (bytesRead > 0) {
-            // Some bytes have been read
+            // Some bytes have been read, hand them over right away
+            if (firstByteAt) {
+                *firstByteAt = std::chrono::steady_clock::now();
+            }
             totalBytesRead += bytesRead;
-            // Buffer full, return here
-            if (totalBytesRead >= bufferSize)
-                return totalBytesRead;
+            return totalBytesRead;
         } else {
-            std::cout << "No data, sleeping for some time" << std::endl;
-            // bytesRead was 0. Sleep for a but to avoid loading the cpu
-            std::this_thread::sleep_for(std::chrono::seconds(1));
+            // Readable but no data means end of file, the device was hung up (eg: USB adapter unplugged).
+            // Return what we have, the next Read will report the error
+            std::cout << "Device hung up" << std::endl;
+            return totalBytesRead > 0 ? static_cast<int>(totalBytesRead) : -1;
         }
     } while (std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::system_clock::now() - startTime) < timeout);
     // Timeout reached, return the number of bytes read